@@ -0,0 +1,477 @@
+/*
+    BB_SramBigInt.cpp - Library for big integer arithmetic in the serial SRAM.
+    Released into the public domain.
+*/
+
+#include "Arduino.h"
+#include "BB_SramBigInt.h"
+
+byte BB_SramBigInt::_windowA[BB_SRAMBIGINT_WINDOW];
+byte BB_SramBigInt::_windowB[BB_SRAMBIGINT_WINDOW];
+byte BB_SramBigInt::_windowProduct[2 * BB_SRAMBIGINT_WINDOW];
+byte BB_SramBigInt::_windowTarget[2 * BB_SRAMBIGINT_WINDOW];
+
+// ----- start: Implementation of SramBigInt -----
+
+    // ---- start: constructor SramBigInt
+
+BB_SramBigInt::BB_SramBigInt(word startAddress, word capacity){
+    this->_startAddress = startAddress;
+    if ((((unsigned long int) startAddress) + capacity) <= BB_SramStack::_maxSramCapacity){
+        this->_capacity = capacity;
+    } else {
+        this->_capacity = 0;
+    }
+    this->_length = 0;
+}
+    // ---- end: constructor SramBigInt
+
+    // ---- start: public methods of SramBigInt -----
+
+word BB_SramBigInt::getCapacity(){
+    return this->_capacity;
+}
+
+
+word BB_SramBigInt::getLength(){
+    return this->_length;
+}
+
+
+boolean BB_SramBigInt::isZero(){
+    return (this->_length == 0);
+}
+
+
+byte BB_SramBigInt::set(unsigned long value){
+    byte limbs[4];
+    byte length = 0;
+    while (value > 0){
+        limbs[length] = (byte) value;
+        value = value >> 8;
+        length++;
+    }
+    if (length > this->_capacity){
+        return 1;
+    }
+    if (length > 0){
+        BB_SramStack::_beginSequentialAccess();
+        BB_SramStack::_writeBlock(this->_startAddress, limbs, length);
+    }
+    this->_length = length;
+    return 0;
+}
+
+
+byte BB_SramBigInt::copy(BB_SramBigInt &source){
+    if (&source == this){
+        return 0;
+    }
+    if (source._length > this->_capacity){
+        return 1;
+    }
+    BB_SramStack::_beginSequentialAccess();
+    _copy(this->_startAddress, source._startAddress, source._length);
+    this->_length = source._length;
+    return 0;
+}
+
+
+byte BB_SramBigInt::getLimb(word index){
+    byte limb = 0;
+    if (index < this->_length){
+        BB_SramStack::_beginSequentialAccess();
+        BB_SramStack::_readBlock(this->_startAddress + index, &limb, 1);
+    }
+    return limb;
+}
+
+
+int BB_SramBigInt::compare(BB_SramBigInt &other){
+    if (this->_length != other._length){
+        return (this->_length < other._length) ? -1 : 1;
+    }
+    if (&other == this){
+        return 0;
+    }
+    BB_SramStack::_beginSequentialAccess();
+    // compare from the most significant limb downwards
+    word remaining = this->_length;
+    while (remaining > 0){
+        byte count = (remaining < BB_SRAMBIGINT_WINDOW) ? (byte) remaining : BB_SRAMBIGINT_WINDOW;
+        remaining = remaining - count;
+        BB_SramStack::_readBlock(this->_startAddress + remaining, _windowA, count);
+        BB_SramStack::_readBlock(other._startAddress + remaining, _windowB, count);
+        for (byte i = count; i > 0; i--){
+            if (_windowA[i - 1] != _windowB[i - 1]){
+                return (_windowA[i - 1] < _windowB[i - 1]) ? -1 : 1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+byte BB_SramBigInt::add(BB_SramBigInt &addend){
+    word addendLength = addend._length;
+    word length = this->_length;
+    if (addendLength > this->_capacity){
+        return 1;
+    }
+    BB_SramStack::_beginSequentialAccess();
+    if (addendLength > length){
+        // the limbs above _length are undefined
+        _zero(this->_startAddress + length, addendLength - length);
+        length = addendLength;
+    }
+    byte carry = _addTo(this->_startAddress, length, addend._startAddress, addendLength);
+    if (carry){
+        if (length < this->_capacity){
+            BB_SramStack::_writeBlock(this->_startAddress + length, &carry, 1);
+            length++;
+        } else {
+            // the sum is truncated to the capacity
+            this->_length = this->_significantLength(length);
+            return 1;
+        }
+    }
+    this->_length = length;
+    return 0;
+}
+
+
+byte BB_SramBigInt::subtract(BB_SramBigInt &subtrahend){
+    if (this->compare(subtrahend) < 0){
+        return 1;
+    }
+    BB_SramStack::_beginSequentialAccess();
+    _subtractFrom(this->_startAddress, this->_length, subtrahend._startAddress, subtrahend._length);
+    this->_length = this->_significantLength(this->_length);
+    return 0;
+}
+
+
+byte BB_SramBigInt::multiplySmall(word factor){
+    if ((this->_length == 0) || (factor == 1)){
+        return 0;
+    }
+    if (factor == 0){
+        this->_length = 0;
+        return 0;
+    }
+    BB_SramStack::_beginSequentialAccess();
+    word carry = 0; // limb * factor + carry < 256 * factor -> the carry fits into 16 bit
+    word offset = 0;
+    while (offset < this->_length){
+        word remaining = this->_length - offset;
+        byte count = (remaining < BB_SRAMBIGINT_WINDOW) ? (byte) remaining : BB_SRAMBIGINT_WINDOW;
+        BB_SramStack::_readBlock(this->_startAddress + offset, _windowA, count);
+        for (byte i = 0; i < count; i++){
+            unsigned long product = ((unsigned long) _windowA[i]) * factor + carry;
+            _windowA[i] = (byte) product;
+            carry = (word) (product >> 8);
+        }
+        BB_SramStack::_writeBlock(this->_startAddress + offset, _windowA, count);
+        offset = offset + count;
+    }
+    // append the carry as new limbs (at most 2)
+    word length = this->_length;
+    byte count = 0;
+    while ((carry > 0) && (length + count < this->_capacity)){
+        _windowA[count] = (byte) carry;
+        carry = carry >> 8;
+        count++;
+    }
+    if (count > 0){
+        BB_SramStack::_writeBlock(this->_startAddress + length, _windowA, count);
+        length = length + count;
+    }
+    if (carry > 0){
+        // the product is truncated to the capacity
+        this->_length = this->_significantLength(length);
+        return 1;
+    }
+    this->_length = length;
+    return 0;
+}
+
+
+word BB_SramBigInt::divideSmall(word divisor){
+    if (divisor == 0){
+        return 0xFFFF;
+    }
+    if (this->_length == 0){
+        return 0;
+    }
+    BB_SramStack::_beginSequentialAccess();
+    unsigned long remainder = 0; // remainder < divisor -> (remainder << 8) + limb fits into 24 bit
+    word remaining = this->_length;
+    while (remaining > 0){
+        byte count = (remaining < BB_SRAMBIGINT_WINDOW) ? (byte) remaining : BB_SRAMBIGINT_WINDOW;
+        remaining = remaining - count;
+        BB_SramStack::_readBlock(this->_startAddress + remaining, _windowA, count);
+        for (byte i = count; i > 0; i--){
+            unsigned long current = (remainder << 8) | _windowA[i - 1];
+            unsigned long quotient = current / divisor;
+            _windowA[i - 1] = (byte) quotient;
+            remainder = current - quotient * divisor;
+        }
+        BB_SramStack::_writeBlock(this->_startAddress + remaining, _windowA, count);
+    }
+    this->_length = this->_significantLength(this->_length);
+    return (word) remainder;
+}
+
+
+byte BB_SramBigInt::multiply(BB_SramBigInt &a, BB_SramBigInt &b){
+    if ((&a == this) || (&b == this)){
+        return 1;
+    }
+    if ((((unsigned long) a._length) + b._length) > this->_capacity){
+        return 1;
+    }
+    if ((a._length == 0) || (b._length == 0)){
+        this->_length = 0;
+        return 0;
+    }
+    BB_SramStack::_beginSequentialAccess();
+    _multiplySchoolbook(this->_startAddress, a._startAddress, a._length, b._startAddress, b._length);
+    this->_length = this->_significantLength(a._length + b._length);
+    return 0;
+}
+
+
+byte BB_SramBigInt::multiply(BB_SramBigInt &a, BB_SramBigInt &b, BB_SramBigInt &scratch){
+    if ((&a == this) || (&b == this) || (&scratch == this) || (&scratch == &a) || (&scratch == &b)){
+        return 1;
+    }
+    if ((((unsigned long) a._length) + b._length) > this->_capacity){
+        return 1;
+    }
+    if ((a._length == 0) || (b._length == 0)){
+        this->_length = 0;
+        return 0;
+    }
+    BB_SramStack::_beginSequentialAccess();
+    _multiplyKaratsuba(this->_startAddress, a._startAddress, a._length, b._startAddress, b._length,
+                       scratch._startAddress, scratch._capacity);
+    this->_length = this->_significantLength(a._length + b._length);
+    scratch._length = 0;
+    return 0;
+}
+
+    // ---- end: public methods of SramBigInt -----
+
+    // ---- start: private methods of SramBigInt -----
+
+word BB_SramBigInt::_significantLength(word length){
+    while (length > 0){
+        byte count = (length < BB_SRAMBIGINT_WINDOW) ? (byte) length : BB_SRAMBIGINT_WINDOW;
+        BB_SramStack::_readBlock(this->_startAddress + length - count, _windowA, count);
+        for (byte i = count; i > 0; i--){
+            if (_windowA[i - 1] != 0){
+                return length;
+            }
+            length--;
+        }
+    }
+    return 0;
+}
+
+void BB_SramBigInt::_zero(word address, word count){
+    memset(_windowTarget, 0, sizeof(_windowTarget));
+    while (count > 0){
+        byte chunk = (count < sizeof(_windowTarget)) ? (byte) count : sizeof(_windowTarget);
+        BB_SramStack::_writeBlock(address, _windowTarget, chunk);
+        address = address + chunk;
+        count = count - chunk;
+    }
+}
+
+void BB_SramBigInt::_copy(word target, word source, word count){
+    while (count > 0){
+        byte chunk = (count < sizeof(_windowTarget)) ? (byte) count : sizeof(_windowTarget);
+        BB_SramStack::_readBlock(source, _windowTarget, chunk);
+        BB_SramStack::_writeBlock(target, _windowTarget, chunk);
+        source = source + chunk;
+        target = target + chunk;
+        count = count - chunk;
+    }
+}
+
+// buffer must not be _windowTarget
+byte BB_SramBigInt::_addWindow(word address, const byte *buffer, byte count, byte carry){
+    BB_SramStack::_readBlock(address, _windowTarget, count);
+    for (byte i = 0; i < count; i++){
+        word sum = (word) _windowTarget[i] + buffer[i] + carry;
+        _windowTarget[i] = (byte) sum;
+        carry = (byte) (sum >> 8);
+    }
+    BB_SramStack::_writeBlock(address, _windowTarget, count);
+    return carry;
+}
+
+// buffer must not be _windowTarget
+byte BB_SramBigInt::_subtractWindow(word address, const byte *buffer, byte count, byte borrow){
+    BB_SramStack::_readBlock(address, _windowTarget, count);
+    for (byte i = 0; i < count; i++){
+        int difference = (int) _windowTarget[i] - buffer[i] - borrow;
+        _windowTarget[i] = (byte) difference;
+        borrow = (difference < 0) ? 1 : 0;
+    }
+    BB_SramStack::_writeBlock(address, _windowTarget, count);
+    return borrow;
+}
+
+byte BB_SramBigInt::_propagateCarry(word address, word count, byte carry){
+    while ((carry > 0) && (count > 0)){
+        byte chunk = (count < sizeof(_windowTarget)) ? (byte) count : sizeof(_windowTarget);
+        BB_SramStack::_readBlock(address, _windowTarget, chunk);
+        byte changed = 0;
+        while ((carry > 0) && (changed < chunk)){
+            _windowTarget[changed]++;
+            carry = (_windowTarget[changed] == 0) ? 1 : 0;
+            changed++;
+        }
+        BB_SramStack::_writeBlock(address, _windowTarget, changed);
+        address = address + chunk;
+        count = count - chunk;
+    }
+    return carry;
+}
+
+byte BB_SramBigInt::_propagateBorrow(word address, word count, byte borrow){
+    while ((borrow > 0) && (count > 0)){
+        byte chunk = (count < sizeof(_windowTarget)) ? (byte) count : sizeof(_windowTarget);
+        BB_SramStack::_readBlock(address, _windowTarget, chunk);
+        byte changed = 0;
+        while ((borrow > 0) && (changed < chunk)){
+            borrow = (_windowTarget[changed] == 0) ? 1 : 0;
+            _windowTarget[changed]--;
+            changed++;
+        }
+        BB_SramStack::_writeBlock(address, _windowTarget, changed);
+        address = address + chunk;
+        count = count - chunk;
+    }
+    return borrow;
+}
+
+byte BB_SramBigInt::_addTo(word target, word targetLength, word source, word sourceLength){
+    byte carry = 0;
+    word offset = 0;
+    while (offset < sourceLength){
+        word remaining = sourceLength - offset;
+        byte count = (remaining < BB_SRAMBIGINT_WINDOW) ? (byte) remaining : BB_SRAMBIGINT_WINDOW;
+        BB_SramStack::_readBlock(source + offset, _windowB, count);
+        carry = _addWindow(target + offset, _windowB, count, carry);
+        offset = offset + count;
+    }
+    return _propagateCarry(target + sourceLength, targetLength - sourceLength, carry);
+}
+
+byte BB_SramBigInt::_subtractFrom(word target, word targetLength, word source, word sourceLength){
+    byte borrow = 0;
+    word offset = 0;
+    while (offset < sourceLength){
+        word remaining = sourceLength - offset;
+        byte count = (remaining < BB_SRAMBIGINT_WINDOW) ? (byte) remaining : BB_SRAMBIGINT_WINDOW;
+        BB_SramStack::_readBlock(source + offset, _windowB, count);
+        borrow = _subtractWindow(target + offset, _windowB, count, borrow);
+        offset = offset + count;
+    }
+    return _propagateBorrow(target + sourceLength, targetLength - sourceLength, borrow);
+}
+
+// The factors are cut into windows. The product of each pair of windows is computed in the
+// internal RAM and added to the result at the position of the pair. Thus each limb of the
+// result is read and written once per pair of windows instead of once per pair of limbs.
+void BB_SramBigInt::_multiplySchoolbook(word result, word a, word aLength, word b, word bLength){
+    word resultLength = aLength + bLength;
+    _zero(result, resultLength);
+    word bOffset = 0;
+    while (bOffset < bLength){
+        word bRemaining = bLength - bOffset;
+        byte bCount = (bRemaining < BB_SRAMBIGINT_WINDOW) ? (byte) bRemaining : BB_SRAMBIGINT_WINDOW;
+        BB_SramStack::_readBlock(b + bOffset, _windowB, bCount);
+        word aOffset = 0;
+        while (aOffset < aLength){
+            word aRemaining = aLength - aOffset;
+            byte aCount = (aRemaining < BB_SRAMBIGINT_WINDOW) ? (byte) aRemaining : BB_SRAMBIGINT_WINDOW;
+            BB_SramStack::_readBlock(a + aOffset, _windowA, aCount);
+            // _windowProduct = _windowA * _windowB
+            memset(_windowProduct, 0, aCount + bCount);
+            for (byte j = 0; j < bCount; j++){
+                byte carry = 0;
+                for (byte i = 0; i < aCount; i++){
+                    word product = ((word) _windowA[i]) * _windowB[j] + _windowProduct[i + j] + carry;
+                    _windowProduct[i + j] = (byte) product;
+                    carry = (byte) (product >> 8);
+                }
+                _windowProduct[aCount + j] = carry;
+            }
+            word position = aOffset + bOffset;
+            byte carry = _addWindow(result + position, _windowProduct, aCount + bCount, 0);
+            position = position + aCount + bCount;
+            _propagateCarry(result + position, resultLength - position, carry);
+            aOffset = aOffset + aCount;
+        }
+        bOffset = bOffset + bCount;
+    }
+}
+
+// a = a1 * 256^h + a0, b = b1 * 256^h + b0
+// z0 = a0 * b0 and z2 = a1 * b1 are written directly into the lower and the upper part of the result.
+// z1 = (a0 + a1) * (b0 + b1) - z0 - z2 is computed in the scratch region and added at position h.
+void BB_SramBigInt::_multiplyKaratsuba(word result, word a, word aLength, word b, word bLength,
+                                       word scratch, word scratchLength){
+    if (aLength < bLength){
+        word swap = a;
+        a = b;
+        b = swap;
+        swap = aLength;
+        aLength = bLength;
+        bLength = swap;
+    }
+    word h = (aLength + 1) / 2;
+    unsigned long needed = 4UL * h + 4; // a0 + a1, b0 + b1 and z1
+    if ((bLength <= h) || (bLength < BB_SRAMBIGINT_KARATSUBA_THRESHOLD) || (needed > scratchLength)){
+        _multiplySchoolbook(result, a, aLength, b, bLength);
+        return;
+    }
+    word resultLength = aLength + bLength;
+    word sumA = scratch;
+    word sumB = sumA + h + 1;
+    word z1 = sumB + h + 1;
+    word z1Length = 2 * h + 2;
+    word rest = z1 + z1Length;
+    word restLength = scratchLength - (word) needed;
+
+    // z0 and z2
+    _multiplyKaratsuba(result, a, h, b, h, rest, restLength);
+    _multiplyKaratsuba(result + 2 * h, a + h, aLength - h, b + h, bLength - h, rest, restLength);
+
+    // sumA = a0 + a1, sumB = b0 + b1
+    _copy(sumA, a, h);
+    _zero(sumA + h, 1);
+    _addTo(sumA, h + 1, a + h, aLength - h);
+    _copy(sumB, b, h);
+    _zero(sumB + h, 1);
+    _addTo(sumB, h + 1, b + h, bLength - h);
+
+    // z1 = sumA * sumB - z0 - z2
+    _multiplyKaratsuba(z1, sumA, h + 1, sumB, h + 1, rest, restLength);
+    _subtractFrom(z1, z1Length, result, 2 * h);
+    _subtractFrom(z1, z1Length, result + 2 * h, resultLength - 2 * h);
+
+    // the limbs of z1 above resultLength - h are 0
+    word addLength = resultLength - h;
+    if (z1Length < addLength){
+        addLength = z1Length;
+    }
+    _addTo(result + h, resultLength - h, z1, addLength);
+}
+
+    // ---- end: private methods of SramBigInt -----
+
+// ----- end: Implementation of SramBigInt -----
@@ -0,0 +1,256 @@
+/**
+ * BB_SramBigInt.h - Library which provides arithmetic on big non-negative integers
+ * which are stored in the serial SRAM.
+ *
+ * A BB_SramBigInt object occupies a fixed region of the serial SRAM. The number is
+ * stored as a sequence of 8 bit limbs, the least significant limb at the start address.
+ * Only a few small windows of the internal RAM are used for the computation: the limbs
+ * are streamed through these windows using sequential reads and writes of the serial SRAM.
+ * Therefore numbers with tens of thousands of digits can be handled by the ATmega328P.
+ *
+ * The major methods are:
+ *    add(), subtract() -> addition and subtraction of two big integers
+ *    multiplySmall(), divideSmall() -> multiplication and division by a 16bit number
+ *    multiply() -> product of two big integers (schoolbook or Karatsuba)
+ *
+ * The SRAM has to be initialized in the setup() section using
+ *    BB_SramStack::begin();
+ *
+ * The regions of the objects must not overlap each other or the region of a BB_SramStack
+ * object which is used at the same time.
+ *
+ * Released into the public domain.
+**/
+
+#ifndef BB_SramBigInt_h
+#define BB_SramBigInt_h
+
+#include "Arduino.h"
+#include "BB_SramStack.h"
+
+/**
+ * The amount of limbs which are streamed through the internal RAM at once. The library
+ * uses 6 * BB_SRAMBIGINT_WINDOW bytes of internal RAM. Must not be larger than 127.
+ * This setting and BB_SRAMBIGINT_KARATSUBA_THRESHOLD have to be changed here or be passed as
+ * compiler flags, because a #define in the sketch is not visible when the library is compiled.
+**/
+#ifndef BB_SRAMBIGINT_WINDOW
+#define BB_SRAMBIGINT_WINDOW 16
+#endif
+
+#if (BB_SRAMBIGINT_WINDOW < 1) || (BB_SRAMBIGINT_WINDOW > 127)
+#error "BB_SRAMBIGINT_WINDOW must be between 1 and 127"
+#endif
+
+/**
+ * Operands with less limbs than BB_SRAMBIGINT_KARATSUBA_THRESHOLD are multiplied with the
+ * schoolbook method, even if multiply() is called with a scratch region. Must be at least 4:
+ * below 4 limbs, the halves a0 + a1 are as long as a itself and the recursion does not end.
+**/
+#ifndef BB_SRAMBIGINT_KARATSUBA_THRESHOLD
+#define BB_SRAMBIGINT_KARATSUBA_THRESHOLD 64
+#endif
+
+#if BB_SRAMBIGINT_KARATSUBA_THRESHOLD < 4
+#error "BB_SRAMBIGINT_KARATSUBA_THRESHOLD must be at least 4"
+#endif
+
+/**
+ * BB_SramBigInt objects store one non-negative integer in a region of the serial SRAM.
+ * The capacity of the region is defined in limbs (bytes); a number with n decimal digits
+ * needs about 0.42 * n limbs.
+**/
+class BB_SramBigInt
+{
+    public:
+        /**
+         * Initiates a BB_SramBigInt object with the value 0.
+         * If the starting address + capacity > physical SRAM capacity, the capacity will be set to 0,
+         * i.e. the object can only hold the value 0.
+         * @param startAddress the 16bit address of the least significant limb.
+         * @param capacity the maximum amount of limbs (bytes) of the number.
+        **/
+        BB_SramBigInt(word startAddress, word capacity);
+
+        /**
+         * @return the maximum amount of limbs of the number.
+        **/
+        word getCapacity();
+
+        /**
+         * @return the amount of significant limbs of the number, i.e. 0 if the number is 0.
+        **/
+        word getLength();
+
+        /**
+         * Checks if the number is 0.
+         * @return true if the number is 0
+         *         false else
+        **/
+        boolean isZero();
+
+        /**
+         * Sets the number to a 32bit value.
+         * @param value the new value.
+         * @return 0 if the value could be stored
+         *         >0 if the capacity is too small. The number is not changed.
+        **/
+        byte set(unsigned long value);
+
+        /**
+         * Sets the number to the value of another number.
+         * @param source the number which is copied.
+         * @return 0 if the value could be stored
+         *         >0 if the capacity is too small. The number is not changed.
+        **/
+        byte copy(BB_SramBigInt &source);
+
+        /**
+         * Reads one limb of the number.
+         * @param index 0 refers to the least significant limb.
+         * @return the limb, 0 if index >= getLength().
+        **/
+        byte getLimb(word index);
+
+        /**
+         * Compares the number with another number.
+         * @param other the number to compare with.
+         * @return <0 if this number is smaller than other
+         *         0 if both numbers are equal
+         *         >0 if this number is larger than other
+        **/
+        int compare(BB_SramBigInt &other);
+
+        /**
+         * Adds another number to this number. addend may be this number itself.
+         * @param addend the number which is added.
+         * @return 0 if the sum could be stored
+         *         >0 if the capacity is too small. If the addend is longer than the capacity, the number is
+         *            not changed, else it contains the sum modulo 256^capacity.
+        **/
+        byte add(BB_SramBigInt &addend);
+
+        /**
+         * Subtracts another number from this number.
+         * @param subtrahend the number which is subtracted.
+         * @return 0 if the difference could be stored
+         *         >0 if the subtrahend is larger than this number. The number is not changed.
+        **/
+        byte subtract(BB_SramBigInt &subtrahend);
+
+        /**
+         * Multiplies the number with a 16bit factor.
+         * @param factor the factor.
+         * @return 0 if the product could be stored
+         *         >0 if the capacity is too small. The number contains the product modulo 256^capacity.
+        **/
+        byte multiplySmall(word factor);
+
+        /**
+         * Divides the number by a 16bit divisor. The number is replaced by the quotient.
+         * @param divisor the divisor.
+         * @return the remainder of the division, 0xFFFF if divisor is 0 (the number is not changed).
+        **/
+        word divideSmall(word divisor);
+
+        /**
+         * Sets the number to the product a * b using the schoolbook method.
+         * a and b may be the same object, but none of them may be this number.
+         * @param a the first factor.
+         * @param b the second factor.
+         * @return 0 if the product could be stored
+         *         >0 if the capacity is smaller than a.getLength() + b.getLength() or if a or b is this number.
+         *            The number is not changed.
+        **/
+        byte multiply(BB_SramBigInt &a, BB_SramBigInt &b);
+
+        /**
+         * Sets the number to the product a * b using the Karatsuba method. The region of "scratch" is
+         * used for the intermediate results; its value is destroyed. About 4 * max(a.getLength(), b.getLength()) + 64
+         * limbs of scratch capacity are needed for the full recursion; with less capacity, the lower levels
+         * of the recursion fall back to the schoolbook method.
+         * a and b may be the same object, but none of them may be this number or scratch.
+         * @param a the first factor.
+         * @param b the second factor.
+         * @param scratch a number whose region is used as temporary memory.
+         * @return 0 if the product could be stored
+         *         >0 if the capacity is smaller than a.getLength() + b.getLength() or if the objects are not distinct.
+         *            The number is not changed.
+        **/
+        byte multiply(BB_SramBigInt &a, BB_SramBigInt &b, BB_SramBigInt &scratch);
+
+    private:
+        word _startAddress; /* the SRAM address of the least significant limb */
+        word _capacity; /* the maximum amount of limbs */
+        word _length; /* the amount of significant limbs; the limbs above are undefined */
+
+        static byte _windowA[BB_SRAMBIGINT_WINDOW]; /* limbs of the first operand */
+        static byte _windowB[BB_SRAMBIGINT_WINDOW]; /* limbs of the second operand */
+        static byte _windowProduct[2 * BB_SRAMBIGINT_WINDOW]; /* the product of _windowA and _windowB */
+        static byte _windowTarget[2 * BB_SRAMBIGINT_WINDOW]; /* limbs of the target which are updated */
+
+        /**
+         * Determines the amount of significant limbs of the limbs [0, length) of the number.
+        **/
+        word _significantLength(word length);
+
+        /**
+         * Sets "count" limbs starting at "address" to 0.
+        **/
+        static void _zero(word address, word count);
+
+        /**
+         * Copies "count" limbs from "source" to "target". The regions must not overlap.
+        **/
+        static void _copy(word target, word source, word count);
+
+        /**
+         * Adds "count" limbs of "buffer" and the incoming carry to the limbs starting at "address".
+         * @return the outgoing carry.
+        **/
+        static byte _addWindow(word address, const byte *buffer, byte count, byte carry);
+
+        /**
+         * Subtracts "count" limbs of "buffer" and the incoming borrow from the limbs starting at "address".
+         * @return the outgoing borrow.
+        **/
+        static byte _subtractWindow(word address, const byte *buffer, byte count, byte borrow);
+
+        /**
+         * Adds a carry to "count" limbs starting at "address".
+         * @return the carry which is left over after the last limb.
+        **/
+        static byte _propagateCarry(word address, word count, byte carry);
+
+        /**
+         * Subtracts a borrow from "count" limbs starting at "address".
+         * @return the borrow which is left over after the last limb.
+        **/
+        static byte _propagateBorrow(word address, word count, byte borrow);
+
+        /**
+         * target[0, targetLength) += source[0, sourceLength) with sourceLength <= targetLength.
+         * @return the carry out of the last target limb.
+        **/
+        static byte _addTo(word target, word targetLength, word source, word sourceLength);
+
+        /**
+         * target[0, targetLength) -= source[0, sourceLength) with sourceLength <= targetLength.
+         * @return the borrow out of the last target limb.
+        **/
+        static byte _subtractFrom(word target, word targetLength, word source, word sourceLength);
+
+        /**
+         * result[0, aLength + bLength) = a[0, aLength) * b[0, bLength) using the schoolbook method.
+        **/
+        static void _multiplySchoolbook(word result, word a, word aLength, word b, word bLength);
+
+        /**
+         * result[0, aLength + bLength) = a[0, aLength) * b[0, bLength) using the Karatsuba method.
+         * scratch[0, scratchLength) is used for the intermediate results.
+        **/
+        static void _multiplyKaratsuba(word result, word a, word aLength, word b, word bLength,
+                                       word scratch, word scratchLength);
+};
+
+#endif
@@ -8,6 +8,54 @@
 #include "BB_SramStack.h"
 
 uint8_t BB_SramStack::_initialized = 0;
+uint8_t BB_SramStack::_interruptSave = 0;
+
+char BB_SramStack::_sramMode = 0;
+
+#if BB_SRAMSTACK_INSTRUMENTATION
+BB_SramCounters BB_SramStack::_globalCounters;
+BB_SramCounters *BB_SramStack::_activeCounters = NULL;
+BB_SramCounters *BB_SramStack::_interruptedCounters = NULL;
+#if BB_SRAMSTACK_TRACE_DEPTH > 0
+BB_SramTraceEntry BB_SramStack::_trace[BB_SRAMSTACK_TRACE_DEPTH];
+byte BB_SramStack::_traceNext = 0;
+byte BB_SramStack::_traceLength = 0;
+#endif
+#endif
+
+// Helpers for the instrumentation. They expand to nothing if BB_SRAMSTACK_INSTRUMENTATION is 0.
+// BB_SRAM_ACTIVATE selects the stack counters which are incremented together with the global counters;
+// every public method which accesses the SRAM has to call it before the first transfer.
+// The counters are updated with interrupts masked, so that counts of an ISR are not lost.
+#if BB_SRAMSTACK_INSTRUMENTATION
+#define BB_SRAM_ACTIVATE(counters) BB_SramStack::_activeCounters = (counters)
+#define BB_SRAM_COUNT(field, n) do { \
+        uint8_t countSreg = SREG; \
+        cli(); \
+        BB_SramStack::_globalCounters.field += (n); \
+        if (BB_SramStack::_activeCounters) BB_SramStack::_activeCounters->field += (n); \
+        SREG = countSreg; \
+    } while (0)
+#define BB_SRAM_RESET_COUNTERS() this->resetCounters()
+// BB_SRAM_WAIT waits for the end of an SPI transfer. The polls are counted in a register and
+// added once afterwards, so that the wait loop is as fast as without instrumentation.
+#define BB_SRAM_WAIT() do { \
+        byte waitPolls = 0; \
+        while (!(SPSR & _BV(SPIF))) waitPolls++; \
+        BB_SRAM_COUNT(busyWaitCycles, waitPolls); \
+    } while (0)
+#else
+#define BB_SRAM_ACTIVATE(counters)
+#define BB_SRAM_COUNT(field, n)
+#define BB_SRAM_RESET_COUNTERS()
+#define BB_SRAM_WAIT() while (!(SPSR & _BV(SPIF)))
+#endif
+
+#if BB_SRAMSTACK_INSTRUMENTATION && (BB_SRAMSTACK_TRACE_DEPTH > 0)
+#define BB_SRAM_TRACE(operation, address) BB_SramStack::_traceOperation((operation), (address))
+#else
+#define BB_SRAM_TRACE(operation, address)
+#endif
 
 // SPIE: SPI Interrupt Enable = 0
 // SPE: SPI Enable = 1
@@ -30,6 +78,7 @@ const byte BB_SramStack::_sramReadData = 0x03;
 const byte BB_SramStack::_sramWriteStatus = 0x01;
 const byte BB_SramStack::_sramReadStatus = 0x05;
 const unsigned long BB_SramStack::_maxSramCapacity = 0x10000;
+const byte BB_SramStack::_maxBlockSession = 32;
 
 
 
@@ -44,6 +93,7 @@ BB_SramStack::BB_SramStack(){
     this->_topAddress = this->_startAddress;  // points to the next free address of the stack
     this->_isEmpty = true;
     this->_isFull = false;
+    BB_SRAM_RESET_COUNTERS();
 }
 
 BB_SramStack::BB_SramStack(char inMode){
@@ -60,6 +110,7 @@ BB_SramStack::BB_SramStack(char inMode){
     this->_topAddress = this->_startAddress;
     this->_isEmpty = true;
     this->_isFull = false;
+    BB_SRAM_RESET_COUNTERS();
 }
 
 BB_SramStack::BB_SramStack(word startAddress, unsigned long size){
@@ -80,6 +131,7 @@ BB_SramStack::BB_SramStack(word startAddress, unsigned long size){
         this->_isEmpty = true;
         this->_isFull = true;
     }
+    BB_SRAM_RESET_COUNTERS();
 }
 
 BB_SramStack::BB_SramStack(char inMode, word startAddress, unsigned long size){
@@ -122,6 +174,7 @@ BB_SramStack::BB_SramStack(char inMode, word startAddress, unsigned long size){
                 this->_isFull = true;
             }
     }
+    BB_SRAM_RESET_COUNTERS();
 }
     // ---- end: constructor SramStack
 
@@ -154,11 +207,22 @@ void BB_SramStack::begin() {
         pinMode(SCK, OUTPUT);
         pinMode(MOSI, OUTPUT);
         //pinMode(MISO, INPUT);
+
+        // All accesses use the virtual chip mode, which also allows single byte transfers.
+        // Thus the status register normally has to be written only once.
+        _setSramStatus('v');
     }
     _initialized++;
     SREG = sreg;
 }
 
+void BB_SramStack::invalidateSramStatus(){
+    uint8_t sreg = SREG;
+    cli();
+    _sramMode = 0;
+    SREG = sreg;
+}
+
 boolean BB_SramStack::isEmpty(){
     return this->_isEmpty;
 }
@@ -171,16 +235,21 @@ boolean BB_SramStack::isFull(){
 
 word BB_SramStack::pop(){
     word cellContent = 0xFFFF;
+    BB_SRAM_ACTIVATE(&this->_counters);
+    BB_SRAM_COUNT(popCalls, 1);
     if (!this->isEmpty()){
+        BB_SRAM_TRACE('o', this->_topAddress);
         if (this->_byteMode){
-            _setSramStatus('b');
+            _setSramStatus('v');
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramReadData);
             _transfer((byte) (this->_topAddress >> 8));
             _transfer((byte) this->_topAddress);
             cellContent = (word) _transfer(0xFF);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
             if (!(this->_topAddress == this->_startAddress)){
                 this->_topAddress--;
             } else {
@@ -193,11 +262,13 @@ word BB_SramStack::pop(){
             _setSramStatus('v');
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramReadData);
             _transfer((byte) (this->_topAddress >> 8));
             _transfer((byte) this->_topAddress);
             cellContent = _transfer16(0xFFFF);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
             if (!(this->_topAddress == this->_startAddress)){
                 this->_topAddress = this->_topAddress - 2;
             } else {
@@ -208,107 +279,140 @@ word BB_SramStack::pop(){
             }
         }
         this->_isFull = false;
-    }    
+    } else {
+        BB_SRAM_COUNT(emptyRejections, 1);
+        BB_SRAM_TRACE('E', this->_topAddress);
+    }
     return cellContent;
 }
 
 
 word BB_SramStack::peek(){
     word cellContent = 0xFFFF;
+    BB_SRAM_ACTIVATE(&this->_counters);
+    BB_SRAM_COUNT(peekCalls, 1);
     if (!this->isEmpty()){
+        BB_SRAM_TRACE('p', this->_topAddress);
         if (this->_byteMode){
-            _setSramStatus('b');
+            _setSramStatus('v');
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramReadData);
             _transfer((byte) (this->_topAddress >> 8));
             _transfer((byte) this->_topAddress);
             cellContent = (word) _transfer(0xFF);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
         } else { // we are in word mode
             _setSramStatus('v');
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramReadData);
             _transfer((byte) (_topAddress >> 8));
             _transfer((byte) _topAddress);
             cellContent = _transfer16(0xFFFF);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
         }
+    } else {
+        BB_SRAM_COUNT(emptyRejections, 1);
+        BB_SRAM_TRACE('E', this->_topAddress);
     }
     return cellContent;
 }
 
 
 byte BB_SramStack::push(byte inData){
+    BB_SRAM_ACTIVATE(&this->_counters);
+    BB_SRAM_COUNT(pushCalls, 1);
     if (!this->isFull()){
         if (this->_byteMode){
             if (!this->isEmpty()){
                 this->_topAddress++;
             }
-            _setSramStatus('b');
+            BB_SRAM_TRACE('u', this->_topAddress);
+            _setSramStatus('v');
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramWriteData);
             _transfer((byte) (this->_topAddress >> 8));
             _transfer((byte) this->_topAddress);
             _transfer(inData);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
             this->_isEmpty = false;
             this->_isFull = (this->_topAddress == (this->_startAddress + ((word) (this->_size - 1))));
         } else {
             if (!this->isEmpty()){
                 this->_topAddress = this->_topAddress + 2;
             }
+            BB_SRAM_TRACE('u', this->_topAddress);
             _setSramStatus('v');
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramWriteData);
             _transfer((byte) (this->_topAddress >> 8));
             _transfer((byte) this->_topAddress);
             _transfer16((word)inData);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
             this->_isEmpty = false;
             this->_isFull = (this->_topAddress == (this->_startAddress + ((word) (2 * this->_size - 2))));
         }
         return 0;
     }
+    BB_SRAM_COUNT(fullRejections, 1);
+    BB_SRAM_TRACE('F', this->_topAddress);
     return 1; 
 }
 
 byte BB_SramStack::push(word inData){
+    BB_SRAM_ACTIVATE(&this->_counters);
+    BB_SRAM_COUNT(pushCalls, 1);
     if (!this->isFull()){
         if (this->_byteMode){
             if (!this->isEmpty()){
                 this->_topAddress++;
             }
-            _setSramStatus('b');
+            BB_SRAM_TRACE('u', this->_topAddress);
+            _setSramStatus('v');
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramWriteData);
             _transfer((byte) (this->_topAddress >> 8));
             _transfer((byte) this->_topAddress);
             _transfer((byte) inData);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
             this->_isEmpty = false;
             this->_isFull = (this->_topAddress == (this->_startAddress + ((word) (this->_size - 1))));
         } else {
             if (!this->isEmpty()){
                 this->_topAddress = this->_topAddress + 2;
             }
+            BB_SRAM_TRACE('u', this->_topAddress);
             _setSramStatus('v');
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramWriteData);
             _transfer((byte) (this->_topAddress >> 8));
             _transfer((byte) this->_topAddress);
             _transfer16((word)inData);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
             this->_isEmpty = false;
             this->_isFull = (this->_topAddress == (this->_startAddress + ((word) (2 * this->_size - 2))));
         }
         return 0;
     }
+    BB_SRAM_COUNT(fullRejections, 1);
+    BB_SRAM_TRACE('F', this->_topAddress);
     return 1; 
 }
 
@@ -347,6 +451,162 @@ BB_StackIterator BB_SramStack::iterator(){
     return iteratorObj;
 }
 
+byte BB_SramStack::fetchAdd(word address, byte delta){
+    uint8_t sreg = _beginAtomic();
+    BB_SRAM_COUNT(atomicCalls, 1);
+    BB_SRAM_TRACE('a', address);
+    byte value = _readCell(address);
+    if (delta != 0){
+        _writeCell(address, (byte) (value + delta));
+    }
+    _endAtomic(sreg);
+    return value;
+}
+
+word BB_SramStack::fetchAdd(word address, word delta){
+    if ((((unsigned long int) address) + 1) >= _maxSramCapacity){
+        // the cell would wrap around the end of the SRAM
+        return 0;
+    }
+    uint8_t sreg = _beginAtomic();
+    BB_SRAM_COUNT(atomicCalls, 1);
+    BB_SRAM_TRACE('a', address);
+    word value = _readCell16(address);
+    if (delta != 0){
+        _writeCell16(address, (word) (value + delta));
+    }
+    _endAtomic(sreg);
+    return value;
+}
+
+byte BB_SramStack::setBits(word address, byte mask){
+    uint8_t sreg = _beginAtomic();
+    BB_SRAM_COUNT(atomicCalls, 1);
+    BB_SRAM_TRACE('s', address);
+    byte value = _readCell(address);
+    if ((value | mask) != value){
+        _writeCell(address, value | mask);
+    }
+    _endAtomic(sreg);
+    return value;
+}
+
+byte BB_SramStack::clearBits(word address, byte mask){
+    uint8_t sreg = _beginAtomic();
+    BB_SRAM_COUNT(atomicCalls, 1);
+    BB_SRAM_TRACE('c', address);
+    byte value = _readCell(address);
+    if ((value & ~mask) != value){
+        _writeCell(address, value & ~mask);
+    }
+    _endAtomic(sreg);
+    return value;
+}
+
+boolean BB_SramStack::compareAndSwap(word address, byte expected, byte desired){
+    uint8_t sreg = _beginAtomic();
+    BB_SRAM_COUNT(atomicCalls, 1);
+    BB_SRAM_TRACE('x', address);
+    boolean swapped = (_readCell(address) == expected);
+    if (swapped && (desired != expected)){
+        _writeCell(address, desired);
+    }
+    _endAtomic(sreg);
+    return swapped;
+}
+
+boolean BB_SramStack::compareAndSwap(word address, word expected, word desired){
+    if ((((unsigned long int) address) + 1) >= _maxSramCapacity){
+        // the cell would wrap around the end of the SRAM
+        return false;
+    }
+    uint8_t sreg = _beginAtomic();
+    BB_SRAM_COUNT(atomicCalls, 1);
+    BB_SRAM_TRACE('x', address);
+    boolean swapped = (_readCell16(address) == expected);
+    if (swapped && (desired != expected)){
+        _writeCell16(address, desired);
+    }
+    _endAtomic(sreg);
+    return swapped;
+}
+
+word BB_SramStack::incrementBin(word baseAddress, word bin){
+    if ((((unsigned long int) baseAddress) + 2UL * bin + 1) >= _maxSramCapacity){
+        // the cell would wrap around the end of the SRAM
+        return 0;
+    }
+    word address = baseAddress + 2 * bin;
+    uint8_t sreg = _beginAtomic();
+    BB_SRAM_COUNT(atomicCalls, 1);
+    BB_SRAM_TRACE('h', address);
+    word count = _readCell16(address);
+    if (count < 0xFFFF){
+        count++;
+        _writeCell16(address, count);
+    }
+    _endAtomic(sreg);
+    return count;
+}
+
+#if BB_SRAMSTACK_INSTRUMENTATION
+void BB_SramStack::getCounters(BB_SramCounters &counters){
+    uint8_t sreg = SREG;
+    cli();
+    counters = this->_counters;
+    SREG = sreg;
+}
+
+void BB_SramStack::resetCounters(){
+    uint8_t sreg = SREG;
+    cli();
+    memset(&this->_counters, 0, sizeof(this->_counters));
+    SREG = sreg;
+}
+
+void BB_SramStack::getGlobalCounters(BB_SramCounters &counters){
+    uint8_t sreg = SREG;
+    cli();
+    counters = _globalCounters;
+    SREG = sreg;
+}
+
+void BB_SramStack::resetGlobalCounters(){
+    uint8_t sreg = SREG;
+    cli();
+    memset(&_globalCounters, 0, sizeof(_globalCounters));
+    SREG = sreg;
+}
+
+#if BB_SRAMSTACK_TRACE_DEPTH > 0
+byte BB_SramStack::getTraceLength(){
+    return _traceLength;
+}
+
+boolean BB_SramStack::getTraceEntry(byte index, BB_SramTraceEntry &entry){
+    boolean found = false;
+    uint8_t sreg = SREG;
+    cli();
+    if (index < _traceLength){
+        // the oldest entry is located _traceLength entries before _traceNext
+        word position = (word) _traceNext + BB_SRAMSTACK_TRACE_DEPTH - _traceLength + index;
+        entry = _trace[position % BB_SRAMSTACK_TRACE_DEPTH];
+        found = true;
+    }
+    SREG = sreg;
+    return found;
+}
+
+void BB_SramStack::clearTrace(){
+    uint8_t sreg = SREG;
+    cli();
+    _traceNext = 0;
+    _traceLength = 0;
+    SREG = sreg;
+}
+#endif
+#endif
+
     // ---- end: public methods of SramStack -----
 
     // ---- start: private methods of SramStack -----
@@ -354,21 +614,25 @@ BB_StackIterator BB_SramStack::iterator(){
 // Before using _transfer() or asserting chip select pins,
 // this function is used to gain exclusive access to the SPI bus
 // and configure the correct settings.
+// Interrupts are masked until _endTransaction(), so that an ISR which uses
+// the atomic operations cannot break into an open chip select session.
 void BB_SramStack::_beginTransaction() {
+    uint8_t sreg = SREG;
+    cli();
+    _interruptSave = sreg;
     SPCR = _spiSettingsSpcr;
     SPSR = _spiSettingsSpsr;
 }
 
 // After performing a group of transfers and releasing the chip select
 // signal, this function allows others to access the SPI bus
-
-// not needed, because this lib does not work with interrupts anyway
-// void SramStack::_endTransaction(void) {
-//
-//}
+void BB_SramStack::_endTransaction() {
+    SREG = _interruptSave;
+}
 
 // Write 8bit to the SPI bus (MOSI pin) and also receive (MISO pin)
 byte BB_SramStack::_transfer(byte data){
+    BB_SRAM_COUNT(spiBytes, 1);
     SPDR = data;
     /*
      * The following NOP introduces a small delay that can prevent the wait
@@ -377,7 +641,7 @@ byte BB_SramStack::_transfer(byte data){
      * speeds it is unnoticed.
      */
     asm volatile("nop");
-    while (!(SPSR & _BV(SPIF))) ; // wait
+    BB_SRAM_WAIT(); // wait
     return SPDR;
 }
 
@@ -385,36 +649,185 @@ byte BB_SramStack::_transfer(byte data){
 word BB_SramStack::_transfer16(word data){
     union { word val; struct { byte lsb; byte msb; }; } in, out;
     in.val = data;
+    BB_SRAM_COUNT(spiBytes, 2);
     SPDR = in.msb;
     asm volatile("nop"); 
-    while (!(SPSR & _BV(SPIF))) ;
+    BB_SRAM_WAIT();
     out.msb = SPDR;
     SPDR = in.lsb;
     asm volatile("nop");
-    while (!(SPSR & _BV(SPIF))) ;
+    BB_SRAM_WAIT();
     out.lsb = SPDR;
     return out.val;
 }
 
+// The status register is only written if the mode changes. Interrupts are masked, so that
+// _sramMode always matches the status register, even if an ISR uses the atomic operations.
 void BB_SramStack::_setSramStatus(char inMode){
+    uint8_t sreg = SREG;
+    cli();
+    if (inMode == _sramMode){
+        BB_SRAM_COUNT(redundantStatusWrites, 1);
+        SREG = sreg;
+        return;
+    }
+    BB_SRAM_COUNT(statusWrites, 1);
+    _sramMode = inMode;
     switch (inMode) {
         case 'b': // byte mode - no hold: B00000001
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramWriteStatus);
             _transfer(0x01);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
             break;
         case 'v': // virtual chip mode (vrtm) - no hold: B01000001
             _beginTransaction();
             digitalWrite(_sramSelect, LOW);
+            BB_SRAM_COUNT(chipSelects, 1);
             _transfer(_sramWriteStatus);
             _transfer(0x41);
             digitalWrite(_sramSelect, HIGH);
+            _endTransaction();
             break;
     }
+    SREG = sreg;
+}
+
+byte BB_SramStack::_readCell(word address){
+    _beginTransaction();
+    digitalWrite(_sramSelect, LOW);
+    BB_SRAM_COUNT(chipSelects, 1);
+    _transfer(_sramReadData);
+    _transfer((byte) (address >> 8));
+    _transfer((byte) address);
+    byte value = _transfer(0xFF);
+    digitalWrite(_sramSelect, HIGH);
+    _endTransaction();
+    return value;
+}
+
+void BB_SramStack::_writeCell(word address, byte value){
+    _beginTransaction();
+    digitalWrite(_sramSelect, LOW);
+    BB_SRAM_COUNT(chipSelects, 1);
+    _transfer(_sramWriteData);
+    _transfer((byte) (address >> 8));
+    _transfer((byte) address);
+    _transfer(value);
+    digitalWrite(_sramSelect, HIGH);
+    _endTransaction();
+}
+
+word BB_SramStack::_readCell16(word address){
+    _beginTransaction();
+    digitalWrite(_sramSelect, LOW);
+    BB_SRAM_COUNT(chipSelects, 1);
+    _transfer(_sramReadData);
+    _transfer((byte) (address >> 8));
+    _transfer((byte) address);
+    word value = _transfer16(0xFFFF);
+    digitalWrite(_sramSelect, HIGH);
+    _endTransaction();
+    return value;
+}
+
+void BB_SramStack::_writeCell16(word address, word value){
+    _beginTransaction();
+    digitalWrite(_sramSelect, LOW);
+    BB_SRAM_COUNT(chipSelects, 1);
+    _transfer(_sramWriteData);
+    _transfer((byte) (address >> 8));
+    _transfer((byte) address);
+    _transfer16(value);
+    digitalWrite(_sramSelect, HIGH);
+    _endTransaction();
+}
+
+uint8_t BB_SramStack::_beginAtomic(){
+    uint8_t sreg = SREG;
+    cli();
+#if BB_SRAMSTACK_INSTRUMENTATION
+    // the operation may interrupt a stack operation whose counters have to be restored afterwards
+    _interruptedCounters = _activeCounters;
+#endif
+    _beginSequentialAccess();
+    return sreg;
+}
+
+void BB_SramStack::_endAtomic(uint8_t sreg){
+#if BB_SRAMSTACK_INSTRUMENTATION
+    _activeCounters = _interruptedCounters;
+#endif
+    SREG = sreg;
+}
+
+void BB_SramStack::_beginSequentialAccess(){
+    BB_SRAM_ACTIVATE(NULL);
+    _setSramStatus('v');
+}
+
+// Long blocks are split into sessions of at most _maxBlockSession bytes, so that interrupts
+// are not masked for longer than about 90us, independent of the block size.
+void BB_SramStack::_readBlock(word address, byte *buffer, word count){
+    while (count > 0){
+        byte chunk = (count < _maxBlockSession) ? (byte) count : _maxBlockSession;
+        _beginTransaction();
+        digitalWrite(_sramSelect, LOW);
+        BB_SRAM_COUNT(chipSelects, 1);
+        _transfer(_sramReadData);
+        _transfer((byte) (address >> 8));
+        _transfer((byte) address);
+        for (byte i = 0; i < chunk; i++){
+            buffer[i] = _transfer(0xFF);
+        }
+        digitalWrite(_sramSelect, HIGH);
+        _endTransaction();
+        address = address + chunk;
+        buffer = buffer + chunk;
+        count = count - chunk;
+    }
 }
 
+void BB_SramStack::_writeBlock(word address, const byte *buffer, word count){
+    while (count > 0){
+        byte chunk = (count < _maxBlockSession) ? (byte) count : _maxBlockSession;
+        _beginTransaction();
+        digitalWrite(_sramSelect, LOW);
+        BB_SRAM_COUNT(chipSelects, 1);
+        _transfer(_sramWriteData);
+        _transfer((byte) (address >> 8));
+        _transfer((byte) address);
+        for (byte i = 0; i < chunk; i++){
+            _transfer(buffer[i]);
+        }
+        digitalWrite(_sramSelect, HIGH);
+        _endTransaction();
+        address = address + chunk;
+        buffer = buffer + chunk;
+        count = count - chunk;
+    }
+}
+
+#if BB_SRAMSTACK_INSTRUMENTATION && (BB_SRAMSTACK_TRACE_DEPTH > 0)
+void BB_SramStack::_traceOperation(char operation, word address){
+    uint8_t sreg = SREG;
+    cli();
+    _trace[_traceNext].operation = operation;
+    _trace[_traceNext].address = address;
+    _traceNext++;
+    if (_traceNext >= BB_SRAMSTACK_TRACE_DEPTH){
+        _traceNext = 0;
+    }
+    if (_traceLength < BB_SRAMSTACK_TRACE_DEPTH){
+        _traceLength++;
+    }
+    SREG = sreg;
+}
+#endif
+
     // ---- end: private methods of SramStack -----
     
 // ----- end: Implementation of SramStack -----
@@ -442,15 +855,19 @@ boolean BB_StackIterator::hasNext(){
 
 word BB_StackIterator::next(){
     word cellContent = 0xFFFF;
+    BB_SRAM_ACTIVATE(&this->_stack->_counters);
+    BB_SRAM_TRACE('n', this->_currentAddress);
     if (this->_stack->_byteMode){
-        this->_stack->_setSramStatus('b');
+        this->_stack->_setSramStatus('v');
         this->_stack->_beginTransaction();
         digitalWrite(this->_stack->_sramSelect, LOW);
+        BB_SRAM_COUNT(chipSelects, 1);
         this->_stack->_transfer(_stack->_sramReadData);
         this->_stack->_transfer((byte) (this->_currentAddress >> 8));
         this->_stack->_transfer((byte) this->_currentAddress);
         cellContent = (word) this->_stack->_transfer(0xFF);
         digitalWrite(this->_stack->_sramSelect, HIGH);
+        this->_stack->_endTransaction();
         if (this->_currentAddress <= this->_stack->_topAddress){
             if (this->_currentAddress == this->_stack->_topAddress) {
                 this->_hasNext = false;
@@ -462,11 +879,13 @@ word BB_StackIterator::next(){
         this->_stack->_setSramStatus('v');
         this->_stack->_beginTransaction();
         digitalWrite(this->_stack->_sramSelect, LOW);
+        BB_SRAM_COUNT(chipSelects, 1);
         this->_stack->_transfer(this->_stack->_sramReadData);
         this->_stack->_transfer((byte) (this->_currentAddress >> 8));
         this->_stack->_transfer((byte) this->_currentAddress);
         cellContent = this->_stack->_transfer16(0xFFFF);
         digitalWrite(this->_stack->_sramSelect, HIGH);
+        this->_stack->_endTransaction();
         if (this->_currentAddress <= this->_stack->_topAddress){
             if (this->_currentAddress == this->_stack->_topAddress) {
                 this->_hasNext = false;
@@ -27,6 +27,9 @@
  *     next() -> provides the data which is stored on the stack address to
  *               which the iterator is currently referring to
  *
+ * Independent of the stacks, single SRAM cells at arbitrary addresses can be updated atomically
+ * by the static methods fetchAdd(), setBits(), clearBits(), compareAndSwap() and incrementBin().
+ *
  * The parts which cover the SPI communication are taken from the SPI library.
  * 
  * Created by E. Mittermeier, BlueberryE GmbH, Aug. 26, 2015.
@@ -46,7 +49,64 @@
 
 #include "Arduino.h"
 
+/**
+ * Instrumentation of the SRAM accesses.
+ * If BB_SRAMSTACK_INSTRUMENTATION is set to 1, every stack object and the library as a whole
+ * count the SPI traffic and the stack operations (see BB_SramCounters). If it is set to 0 (default),
+ * neither code nor memory is spent on the counters and the related methods do not exist.
+ * BB_SRAMSTACK_TRACE_DEPTH > 0 (max. 255) additionally records the last BB_SRAMSTACK_TRACE_DEPTH operations
+ * in a ring buffer (see BB_SramTraceEntry). It is only used if the instrumentation is enabled.
+ * Both settings have to be changed here or be passed as compiler flags, because a #define in the
+ * sketch is not visible when the library is compiled.
+**/
+#ifndef BB_SRAMSTACK_INSTRUMENTATION
+#define BB_SRAMSTACK_INSTRUMENTATION 0
+#endif
+
+#ifndef BB_SRAMSTACK_TRACE_DEPTH
+#define BB_SRAMSTACK_TRACE_DEPTH 0
+#endif
+
+#if BB_SRAMSTACK_TRACE_DEPTH > 255
+#error "BB_SRAMSTACK_TRACE_DEPTH must not be larger than 255"
+#endif
+
 class BB_StackIterator;
+
+#if BB_SRAMSTACK_INSTRUMENTATION
+/**
+ * The counters which are collected per stack object and globally if BB_SRAMSTACK_INSTRUMENTATION is 1.
+**/
+struct BB_SramCounters
+{
+    unsigned long spiBytes; /* bytes transferred on the SPI bus */
+    unsigned long chipSelects; /* assertions of the chip select signal of the serial SRAM */
+    unsigned long statusWrites; /* writes of the status register of the serial SRAM */
+    unsigned long redundantStatusWrites; /* status writes which were skipped because the mode did not change */
+    unsigned long pushCalls; /* calls of push() */
+    unsigned long popCalls; /* calls of pop() */
+    unsigned long peekCalls; /* calls of peek() */
+    unsigned long fullRejections; /* push() calls which were rejected because the stack was full */
+    unsigned long emptyRejections; /* pop() and peek() calls which were rejected because the stack was empty */
+    unsigned long atomicCalls; /* calls of the atomic cell operations (only counted globally) */
+    unsigned long busyWaitCycles; /* polls of the SPI status register while waiting for the end of a transfer */
+};
+
+#if BB_SRAMSTACK_TRACE_DEPTH > 0
+/**
+ * One entry of the trace ring. "operation" is one of
+ *    'u' push, 'o' pop, 'p' peek, 'n' next() of an iterator,
+ *    'F' push rejected because the stack was full, 'E' pop or peek rejected because the stack was empty,
+ *    'a' fetchAdd, 's' setBits, 'c' clearBits, 'x' compareAndSwap, 'h' incrementBin.
+ * "address" is the SRAM address of the accessed cell (the top address for rejected operations).
+**/
+struct BB_SramTraceEntry
+{
+    char operation;
+    word address;
+};
+#endif
+#endif
     
 /**
  * BB_SramStack objects allow the usage of (parts of) the Serial SRAM as stack.
@@ -59,8 +119,17 @@ class BB_SramStack
     public:
         /**
          * Initializes the serial SRAM. This static method needs to be called in the setup() of the sketch.
+         * The library owns the status register of the serial SRAM: it remembers the mode which it wrote last
+         * and does not write the register again while the mode stays the same. Code which writes the status
+         * register directly (e.g. with the SPI library) has to call invalidateSramStatus() afterwards.
         **/
         static void begin();
+
+        /**
+         * Forgets the remembered mode of the status register of the serial SRAM, so that the next access of
+         * the library writes the register again. Call it after the status register was written by other code.
+        **/
+        static void invalidateSramStatus();
     
         /**
          * Initiates a SramStack object which uses the full capacity (64K bytes) of the serial SRAM.
@@ -155,6 +224,124 @@ class BB_SramStack
          * @return an iterator refering to the first stack element.
         **/
         BB_StackIterator iterator();
+
+        /**
+         * The following static methods update one SRAM cell at an arbitrary address, independent of any stack.
+         * Each of them reads the cell within one chip select and writes it back within a second one (if the
+         * value changes), while interrupts are masked. Thus an ISR and loop() can share cells safely.
+         * All other chip select sessions of the library mask interrupts as well, so an ISR may call these
+         * methods while loop() uses stacks or BB_SramBigInt objects. The ISR must not use stacks or
+         * BB_SramBigInt objects itself: their state is not protected between the sessions.
+         * Word cells are stored with the most significant byte first, like the cells of a word mode stack.
+         * Like push(), the type of the value parameters selects the cell size; cast constants to byte or word.
+        **/
+
+        /**
+         * Adds delta to the byte cell at address (modulo 256). A delta of 0 only reads the cell.
+         * @param address the SRAM address of the cell.
+         * @param delta the value which is added.
+         * @return the content of the cell before the addition.
+        **/
+        static byte fetchAdd(word address, byte delta);
+
+        /**
+         * Adds delta to the word cell at address (modulo 65536). A delta of 0 only reads the cell.
+         * @param address the SRAM address of the most significant byte of the cell.
+         * @param delta the value which is added.
+         * @return the content of the cell before the addition,
+         *         0 if the cell is not located completely within the SRAM (nothing is changed).
+        **/
+        static word fetchAdd(word address, word delta);
+
+        /**
+         * Sets the bits of mask in the byte cell at address.
+         * @param address the SRAM address of the cell.
+         * @param mask the bits which are set.
+         * @return the content of the cell before the operation.
+        **/
+        static byte setBits(word address, byte mask);
+
+        /**
+         * Clears the bits of mask in the byte cell at address.
+         * @param address the SRAM address of the cell.
+         * @param mask the bits which are cleared.
+         * @return the content of the cell before the operation.
+        **/
+        static byte clearBits(word address, byte mask);
+
+        /**
+         * Writes desired to the byte cell at address if the cell contains expected.
+         * @param address the SRAM address of the cell.
+         * @param expected the value which the cell must contain.
+         * @param desired the new value of the cell.
+         * @return true if the cell contained expected and desired was written
+         *         false else
+        **/
+        static boolean compareAndSwap(word address, byte expected, byte desired);
+
+        /**
+         * Writes desired to the word cell at address if the cell contains expected.
+         * @param address the SRAM address of the most significant byte of the cell.
+         * @param expected the value which the cell must contain.
+         * @param desired the new value of the cell.
+         * @return true if the cell contained expected and desired was written
+         *         false else, or if the cell is not located completely within the SRAM
+        **/
+        static boolean compareAndSwap(word address, word expected, word desired);
+
+        /**
+         * Increments one bin of a histogram of word cells. The count saturates at 0xFFFF.
+         * @param baseAddress the SRAM address of bin 0.
+         * @param bin the index of the bin; its cell is located at baseAddress + 2 * bin.
+         * @return the count of the bin after the increment,
+         *         0 if the cell of the bin is not located completely within the SRAM (nothing is changed).
+        **/
+        static word incrementBin(word baseAddress, word bin);
+
+#if BB_SRAMSTACK_INSTRUMENTATION
+        /**
+         * Copies the counters of this stack object (including the accesses of its iterators).
+         * @param counters receives the snapshot of the counters.
+        **/
+        void getCounters(BB_SramCounters &counters);
+
+        /**
+         * Sets all counters of this stack object to 0.
+        **/
+        void resetCounters();
+
+        /**
+         * Copies the counters of all SRAM accesses of the library.
+         * @param counters receives the snapshot of the counters.
+        **/
+        static void getGlobalCounters(BB_SramCounters &counters);
+
+        /**
+         * Sets all global counters to 0.
+        **/
+        static void resetGlobalCounters();
+
+#if BB_SRAMSTACK_TRACE_DEPTH > 0
+        /**
+         * @return the amount of entries which are currently stored in the trace ring.
+        **/
+        static byte getTraceLength();
+
+        /**
+         * Reads one entry of the trace ring.
+         * @param index 0 refers to the oldest entry, getTraceLength() - 1 to the latest one.
+         * @param entry receives the trace entry.
+         * @return true if the entry exists
+         *         false else
+        **/
+        static boolean getTraceEntry(byte index, BB_SramTraceEntry &entry);
+
+        /**
+         * Removes all entries from the trace ring.
+        **/
+        static void clearTrace();
+#endif
+#endif
     
     private:
         boolean _byteMode; /* true if the stack cells have a capacity of 1 byte */
@@ -165,6 +352,25 @@ class BB_SramStack
         boolean _isFull; /* true if last cell of the stack contains valid data */
         
         static uint8_t _initialized; /* counts the number of begin() calls */
+        static uint8_t _interruptSave; /* SREG before the current chip select session */
+        static char _sramMode; /* the mode which was written last to the status register of the serial SRAM */
+
+#if BB_SRAMSTACK_INSTRUMENTATION
+        BB_SramCounters _counters; /* the counters of this stack object */
+        static BB_SramCounters _globalCounters; /* the counters of all SRAM accesses */
+        static BB_SramCounters *_activeCounters; /* the counters of the stack object which is currently accessing the SRAM */
+        static BB_SramCounters *_interruptedCounters; /* _activeCounters of the operation which an atomic operation interrupted */
+#if BB_SRAMSTACK_TRACE_DEPTH > 0
+        static BB_SramTraceEntry _trace[BB_SRAMSTACK_TRACE_DEPTH]; /* the ring of the latest operations */
+        static byte _traceNext; /* the index in _trace which will be written next */
+        static byte _traceLength; /* the amount of valid entries in _trace */
+
+        /**
+         * Appends one entry to the trace ring. The oldest entry is overwritten if the ring is full.
+        **/
+        static void _traceOperation(char operation, word address);
+#endif
+#endif
     
         static const int _sramSelect; /* the pin used for the chip select signal */
         static const byte _sramWriteData; /* the serial Sram command for writing data into the SRAM */
@@ -172,6 +378,7 @@ class BB_SramStack
         static const byte _sramWriteStatus; /* the serial Sram command for setting the status register of the serial SRAM */
         static const byte _sramReadStatus; /* the serial Sram command for reading the content of the status register of the serial SRAM */
         static const unsigned long _maxSramCapacity; /* the physically available SRAM capacity in bytes (currently 0x10000) */
+        static const byte _maxBlockSession; /* the max. amount of data bytes of one chip select session of _readBlock() and _writeBlock() */
       
         static const uint8_t _spiSettingsSpcr; /* the bit pattern which is needed for the SPI SPCR (control) register */
         static const uint8_t _spiSettingsSpsr; /* the bit pattern which is needed for the SPI SPSR (status) register */
@@ -179,18 +386,34 @@ class BB_SramStack
         /**
          * Set the content of the status register of the serial SRAM.
          * Available modes are: byte mode, page mode, page sequential mode, virtual chip mode.
-         * Currently only byte mode is supported.
+         * The register is only written if inMode differs from the last mode which was written (_sramMode).
+         * Writes by other code are not noticed; invalidateSramStatus() resets _sramMode for that case.
         * @param inMode 'b' sets the serial SRAM to byte mode
+        *               'v' sets the serial SRAM to virtual chip mode (used for all accesses of this library)
         **/
         static void _setSramStatus(char inMode); /* set the content of the status register of the serial SRAM */
     
       
         /**
-         * Initializes a communication on the SPI bus.
+         * Initializes a communication on the SPI bus. Interrupts are masked until _endTransaction().
         **/
         static void _beginTransaction();
       
-        // static void _endTransaction(); // not needed, because this lib does not work with interrupts anyway
+        /**
+         * Finishes a communication on the SPI bus and restores the interrupt flag.
+        **/
+        static void _endTransaction();
+
+        /**
+         * Masks interrupts and prepares an atomic operation (see _beginSequentialAccess()).
+         * @return the content of SREG which has to be passed to _endAtomic().
+        **/
+        static uint8_t _beginAtomic();
+
+        /**
+         * Finishes an atomic operation: restores the counters of an interrupted stack operation and SREG.
+        **/
+        static void _endAtomic(uint8_t sreg);
       
         /**
          * Transfers one byte of data on the SPI bus.
@@ -201,8 +424,48 @@ class BB_SramStack
          * Transfers one word (2 bytes) of data on the SPI bus.
         **/
         static word _transfer16(word data);
+
+        /**
+         * Prepares a sequence of _readBlock() and _writeBlock() calls which do not belong to a stack object:
+         * sets the serial SRAM to the sequential mode ('v') and detaches the instrumentation counters of the
+         * stack objects.
+        **/
+        static void _beginSequentialAccess();
+
+        /**
+         * Reads the byte cell at "address" within one chip select.
+        **/
+        static byte _readCell(word address);
+
+        /**
+         * Writes the byte cell at "address" within one chip select.
+        **/
+        static void _writeCell(word address, byte value);
+
+        /**
+         * Reads the word cell at "address" (most significant byte first) within one chip select.
+        **/
+        static word _readCell16(word address);
+
+        /**
+         * Writes the word cell at "address" (most significant byte first) within one chip select.
+        **/
+        static void _writeCell16(word address, word value);
+
+        /**
+         * Reads "count" consecutive bytes starting at "address" within one chip select per _maxBlockSession bytes.
+         * The serial SRAM has to be in sequential mode (see _beginSequentialAccess()).
+        **/
+        static void _readBlock(word address, byte *buffer, word count);
+
+        /**
+         * Writes "count" consecutive bytes starting at "address" within one chip select per _maxBlockSession bytes.
+         * The serial SRAM has to be in sequential mode (see _beginSequentialAccess()).
+        **/
+        static void _writeBlock(word address, const byte *buffer, word count);
         
         friend class BB_StackIterator;
+        friend class BB_SramBigInt;
 };
 
 /**
@@ -0,0 +1,85 @@
+/*
+  Calculate 1000! (2568 decimal digits) in the Uno335 Serial SRAM and print it.
+  The square of the factorial is calculated twice, with the schoolbook method and
+  with the Karatsuba method, and both results are compared.
+  This sketch uses the BB_SramBigInt and the BB_SramStack library.
+
+  The decimal digits are produced from the least significant end by repeated
+  divisions by 10000. A word mode stack reverses the 4 digit groups for printing.
+
+  created 18 Oct. 2026
+*/
+
+#include <BB_SramStack.h>  // include the libraries
+#include <BB_SramBigInt.h>
+
+const word n = 1000;
+
+// the regions of the numbers in the SRAM
+BB_SramBigInt factorial(0x0000, 0x1000);  // 1000! needs 1067 limbs
+BB_SramBigInt square1(0x1000, 0x1000);
+BB_SramBigInt square2(0x2000, 0x1000);
+BB_SramBigInt scratch(0x3000, 0x3000);    // temporary memory for the Karatsuba method
+
+// the stack for the 4 digit groups
+BB_SramStack digitGroups('w', 0x6000, 0x1000);
+
+void setup() {
+    Serial.begin(9600);
+    BB_SramStack::begin();
+
+    unsigned long start = millis();
+    factorial.set(1);
+    for (word i = 2; i <= n; i++) factorial.multiplySmall(i);
+    Serial.print(n);
+    Serial.print("! has ");
+    Serial.print(factorial.getLength());
+    Serial.print(" limbs, calculated in ");
+    Serial.print(millis() - start);
+    Serial.println(" ms");
+
+    start = millis();
+    square1.multiply(factorial, factorial);
+    Serial.print("Schoolbook square: ");
+    Serial.print(millis() - start);
+    Serial.println(" ms");
+
+    start = millis();
+    square2.multiply(factorial, factorial, scratch);
+    Serial.print("Karatsuba square:  ");
+    Serial.print(millis() - start);
+    Serial.println(" ms");
+
+    if (square1.compare(square2) == 0) Serial.println("Both squares are equal");
+    else Serial.println("ERROR: the squares differ");
+
+    Serial.print(n);
+    Serial.println("! =");
+    printDecimal(factorial); // destroys the value of factorial
+    Serial.println();
+}
+
+void loop() {
+}
+
+// Prints the number in decimal notation. The number will be 0 afterwards.
+void printDecimal(BB_SramBigInt &number){
+    digitGroups.clear();
+    while (!number.isZero()) digitGroups.push(number.divideSmall(10000));
+    if (digitGroups.isEmpty()){
+        Serial.print('0');
+        return;
+    }
+    // the most significant group is printed without leading zeros
+    Serial.print(digitGroups.pop());
+    byte groups = 1;
+    while (!digitGroups.isEmpty()){
+        word group = digitGroups.pop();
+        for (word limit = 1000; limit > 1; limit = limit / 10){
+            if (group < limit) Serial.print('0');
+        }
+        Serial.print(group);
+        groups++;
+        if (groups % 16 == 0) Serial.println();
+    }
+}
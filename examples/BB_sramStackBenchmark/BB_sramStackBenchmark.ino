@@ -0,0 +1,368 @@
+/*
+  Measure the cost of every public operation of the BB_SramStack library
+  on the Uno335 Serial Sram.
+
+  Timer1 runs without prescaler, so one timer tick is one CPU cycle. Its
+  overflow interrupt extends the 16 bit counter to 32 bit, which allows to
+  time the fill and drain of the complete SRAM as well.
+
+  Every measurement is repeated RUNS times and the median is reported.
+  Single operations are timed in batches of BATCH calls; the cost of an
+  empty batch loop of the same shape (with or without storing a result)
+  is measured once and subtracted.
+
+  The report is printed over serial as comma separated lines:
+    BENCH_BEGIN,<format version>,<F_CPU>,<RUNS>,<BATCH>
+    BENCH,<operation>,<mode>,<calls>,<cycles per call>,<ns per call>
+    BENCH_END
+  <mode> is "b" for a byte mode stack and "w" for a word mode stack, and
+  "b" or "w" for the cell size of the atomic cell operations.
+  Most rows time exactly the named call. Exceptions:
+    iterator+hasNext: iterator() plus one hasNext() on the new iterator
+    scan: a complete scan of BATCH elements; <calls> counts the elements,
+          and one element costs one hasNext() and one next() (plus a
+          share of the final hasNext() which ends the scan)
+    fill, drain: one element costs one isFull() and one push(word), or
+          one isEmpty() and one pop(), respectively
+  All lines which do not start with "BENCH" are comments for humans.
+
+  Note: Timer1 is used by this sketch, i.e. the Servo library and
+  analogWrite() on pin 9 and 10 cannot be used at the same time.
+
+  created 18 Oct. 2026
+*/
+
+#include <BB_SramStack.h> // include the library
+
+// amount of repetitions of each measurement; the median is reported
+const byte RUNS = 7;
+// amount of calls which are timed together for the single operations
+const word BATCH = 64;
+
+// the stacks which are measured; both use the full SRAM capacity
+BB_SramStack stack8('b');
+BB_SramStack stack16('w');
+
+// the upper 16 bit of the cycle counter
+volatile word timerOverflows = 0;
+
+// keeps the compiler from removing calls whose results are not used
+volatile word sink;
+
+// the results of the single runs of one measurement
+unsigned long samples[RUNS];
+
+// the cycles needed by the empty batch loops with and without storing a result
+unsigned long loopOverhead = 0;
+unsigned long loopOverheadNoStore = 0;
+
+ISR(TIMER1_OVF_vect){
+    timerOverflows++;
+}
+
+void setup() {
+    Serial.begin(115200);
+    BB_SramStack::begin();
+    startCycleCounter();
+    loopOverhead = measureOverhead(true);
+    loopOverheadNoStore = measureOverhead(false);
+}
+
+void loop() {
+    Serial.print(F("BENCH_BEGIN,2,"));
+    Serial.print(F_CPU);
+    Serial.print(',');
+    Serial.print(RUNS);
+    Serial.print(',');
+    Serial.println(BATCH);
+
+    benchmarkStack(stack8, "b");
+    benchmarkStack(stack16, "w");
+    benchmarkAtomics();
+
+    Serial.println(F("BENCH_END"));
+    Serial.println(F("# next report in 10 seconds"));
+    delay(10000);
+}
+
+// ----- cycle counter -----
+
+// Timer1 in normal mode without prescaler: TCNT1 counts CPU cycles.
+void startCycleCounter(){
+    uint8_t sreg = SREG;
+    cli();
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TCNT1 = 0;
+    TIFR1 = _BV(TOV1);
+    TIMSK1 = _BV(TOIE1);
+    TCCR1B = _BV(CS10);
+    SREG = sreg;
+}
+
+// Returns the 32 bit cycle count. An overflow which is pending but not
+// yet handled by the ISR is taken into account.
+unsigned long cycles(){
+    uint8_t sreg = SREG;
+    cli();
+    word low = TCNT1;
+    word high = timerOverflows;
+    if ((TIFR1 & _BV(TOV1)) && (low < 0x8000)) high++;
+    SREG = sreg;
+    return ((unsigned long) high << 16) | low;
+}
+
+// ----- statistics -----
+
+// sorts the samples and returns the median
+unsigned long median(){
+    for (byte i = 1; i < RUNS; i++){
+        unsigned long value = samples[i];
+        byte j = i;
+        while ((j > 0) && (samples[j - 1] > value)){
+            samples[j] = samples[j - 1];
+            j--;
+        }
+        samples[j] = value;
+    }
+    return samples[RUNS / 2];
+}
+
+// withStore: the measured loop stores each result in "sink"
+unsigned long measureOverhead(boolean withStore){
+    for (byte run = 0; run < RUNS; run++){
+        unsigned long start = cycles();
+        if (withStore){
+            for (word i = 0; i < BATCH; i++) sink = i;
+        } else {
+            // the empty asm statement keeps the compiler from removing the loop
+            for (word i = 0; i < BATCH; i++) asm volatile("" : : "r" (i));
+        }
+        samples[run] = cycles() - start;
+    }
+    return median();
+}
+
+// Prints one report line. totalCycles is the median over all runs for "calls" calls.
+void report(const char *operation, const char *mode, unsigned long calls, unsigned long totalCycles){
+    unsigned long perCall = (totalCycles + calls / 2) / calls;
+    Serial.print(F("BENCH,"));
+    Serial.print(operation);
+    Serial.print(',');
+    Serial.print(mode);
+    Serial.print(',');
+    Serial.print(calls);
+    Serial.print(',');
+    Serial.print(perCall);
+    Serial.print(',');
+    Serial.println((perCall * 1000UL) / (F_CPU / 1000000UL));
+}
+
+// median of the batch results minus the cost of the matching empty loop
+void reportNet(const char *operation, const char *mode, unsigned long overhead){
+    unsigned long total = median();
+    if (total > overhead) total = total - overhead;
+    else total = 0;
+    report(operation, mode, BATCH, total);
+}
+
+// for batches which store every result in "sink"
+void reportBatch(const char *operation, const char *mode){
+    reportNet(operation, mode, loopOverhead);
+}
+
+// ----- the measurements -----
+
+// fills the stack with "count" elements without timing
+void prefill(BB_SramStack &stack, word count){
+    stack.clear();
+    for (word i = 0; i < count; i++) stack.push((word) i);
+}
+
+void benchmarkStack(BB_SramStack &stack, const char *mode){
+    unsigned long start;
+    byte run;
+    word i;
+
+    // push(byte)
+    for (run = 0; run < RUNS; run++){
+        stack.clear();
+        start = cycles();
+        for (i = 0; i < BATCH; i++) stack.push((byte) i);
+        samples[run] = cycles() - start;
+    }
+    reportNet("push8", mode, loopOverheadNoStore);
+
+    // push(word)
+    for (run = 0; run < RUNS; run++){
+        stack.clear();
+        start = cycles();
+        for (i = 0; i < BATCH; i++) stack.push((word) i);
+        samples[run] = cycles() - start;
+    }
+    reportNet("push16", mode, loopOverheadNoStore);
+
+    // peek()
+    prefill(stack, BATCH);
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = stack.peek();
+        samples[run] = cycles() - start;
+    }
+    reportBatch("peek", mode);
+
+    // pop()
+    for (run = 0; run < RUNS; run++){
+        prefill(stack, BATCH);
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = stack.pop();
+        samples[run] = cycles() - start;
+    }
+    reportBatch("pop", mode);
+
+    // isEmpty() and isFull()
+    prefill(stack, 1);
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = stack.isEmpty();
+        samples[run] = cycles() - start;
+    }
+    reportBatch("isEmpty", mode);
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = stack.isFull();
+        samples[run] = cycles() - start;
+    }
+    reportBatch("isFull", mode);
+
+    // clear()
+    for (run = 0; run < RUNS; run++){
+        prefill(stack, 1);
+        start = cycles();
+        for (i = 0; i < BATCH; i++) stack.clear();
+        samples[run] = cycles() - start;
+    }
+    reportNet("clear", mode, loopOverheadNoStore);
+
+    // iterator(), hasNext() and next()
+    prefill(stack, BATCH);
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++){
+            BB_StackIterator iter = stack.iterator();
+            sink = iter.hasNext();
+        }
+        samples[run] = cycles() - start;
+    }
+    reportBatch("iterator+hasNext", mode);
+    for (run = 0; run < RUNS; run++){
+        BB_StackIterator iter = stack.iterator();
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = iter.hasNext();
+        samples[run] = cycles() - start;
+    }
+    reportBatch("hasNext", mode);
+    for (run = 0; run < RUNS; run++){
+        BB_StackIterator iter = stack.iterator();
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = iter.next();
+        samples[run] = cycles() - start;
+    }
+    reportBatch("next", mode);
+
+    // a complete scan of a filled stack using an iterator; reported per element
+    for (run = 0; run < RUNS; run++){
+        BB_StackIterator iter = stack.iterator();
+        start = cycles();
+        while (iter.hasNext()) sink = iter.next();
+        samples[run] = cycles() - start;
+    }
+    report("scan", mode, BATCH, median());
+
+    // fill the complete SRAM and drain it again
+    unsigned long count = 0;
+    for (run = 0; run < RUNS; run++){
+        stack.clear();
+        count = 0;
+        start = cycles();
+        while (!stack.isFull()){
+            stack.push((word) count);
+            count++;
+        }
+        samples[run] = cycles() - start;
+    }
+    report("fill", mode, count, median());
+
+    for (run = 0; run < RUNS; run++){
+        if (!stack.isFull()){
+            // the previous run drained the stack; refill it without timing
+            while (!stack.isFull()) stack.push((word) 0);
+        }
+        count = 0;
+        start = cycles();
+        while (!stack.isEmpty()){
+            sink = stack.pop();
+            count++;
+        }
+        samples[run] = cycles() - start;
+    }
+    report("drain", mode, count, median());
+
+    stack.clear();
+}
+
+// the atomic cell operations work on arbitrary addresses; the cells used here
+// are overwritten by the stack measurements anyway
+void benchmarkAtomics(){
+    const word cell = 0x0000;
+    unsigned long start;
+    byte run;
+    word i;
+
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = BB_SramStack::fetchAdd(cell, (byte) 1);
+        samples[run] = cycles() - start;
+    }
+    reportBatch("fetchAdd", "b");
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = BB_SramStack::fetchAdd(cell, (word) 1);
+        samples[run] = cycles() - start;
+    }
+    reportBatch("fetchAdd", "w");
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = BB_SramStack::fetchAdd(cell, (word) 0);
+        samples[run] = cycles() - start;
+    }
+    reportBatch("fetchAdd0", "w");
+
+    // alternate between setting and clearing, so that every call writes the cell
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++){
+            if (i & 1) sink = BB_SramStack::clearBits(cell, 0x01);
+            else sink = BB_SramStack::setBits(cell, 0x01);
+        }
+        samples[run] = cycles() - start;
+    }
+    reportBatch("setClearBits", "b");
+
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++){
+            word expected = BB_SramStack::fetchAdd(cell, (word) 0);
+            sink = BB_SramStack::compareAndSwap(cell, expected, (word) (expected + 1));
+        }
+        samples[run] = cycles() - start;
+    }
+    reportBatch("readAndCas", "w");
+
+    for (run = 0; run < RUNS; run++){
+        start = cycles();
+        for (i = 0; i < BATCH; i++) sink = BB_SramStack::incrementBin(cell, i);
+        samples[run] = cycles() - start;
+    }
+    reportBatch("incrementBin", "w");
+}